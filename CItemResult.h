@@ -0,0 +1,16 @@
+#pragma once
+#include <memory>
+
+using namespace std;
+
+// Base class of the result produced by processing an item. It should be inherited by the class that holds the output of
+// CThread::ProcessItem, when the items are processed with the result cache enabled in CThreadsManager.
+// A result may be shared by many items that have the same key, so it must not be modified after it is set on an item.
+class CItemResult
+{
+public:
+	virtual ~CItemResult() {}
+	virtual size_t GetSize() const = 0; // Approximate number of bytes used by the result, which is counted against the memory budget of the result cache.
+};
+
+typedef shared_ptr<const CItemResult>	ItemResultPtr;
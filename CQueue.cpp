@@ -37,6 +37,7 @@ bool CQueue::Enqueue(CQueueItem* pItem, bool bHighPriority/* = false*/)
 		// The caller is responsible for deallocating the pItem object because it is not inserted to the queue in this case, or retry inserting it later.
 		fwprintf(stderr, L"Method(%s):Line(%d)ERROR: Failed to enqueue item for processing '%s', because we reached the maximum allowed number of items in the queue (%d).\n",
 			__FUNCTIONW__, __LINE__, pItem->GetKey(), (int)m_cstMaxQueueItems);
+		LeaveCriticalSection(&m_ItemsProtector);
 		return false;
 	}
 
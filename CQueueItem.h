@@ -1,5 +1,6 @@
 #pragma once
 #include <list>
+#include "CItemResult.h"
 
 using namespace std;
 
@@ -8,17 +9,20 @@ class CQueueItem
 public:
 	typedef enum { eNotStarted, eInProgress, eCompleted, eCancelled } States;
 private:
-	States	m_State;
+	States			m_State;
+	ItemResultPtr	m_pResult;
 public:
 	CQueueItem();
-	~CQueueItem();
+	virtual ~CQueueItem();
 	virtual wchar_t* GetKey() = 0;
-	void ReSetWorkState() { m_State = eNotStarted; }
+	void ReSetWorkState() { m_State = eNotStarted; m_pResult.reset(); }
 	void SetWorkStarted() { m_State = eInProgress; }
 	void SetWorkComplete() { m_State = eCompleted; }
 	void SetWorkCancelled() { m_State = eCancelled; }
 	bool IsCompleted() { return (m_State == eCompleted); }
 	bool IsCancelled() { return (m_State == eCancelled); }
+	void SetResult(const ItemResultPtr& pResult) { m_pResult = pResult; }
+	ItemResultPtr GetResult() { return m_pResult; }
 };
 
 typedef list<CQueueItem*>		ItemsQueue;
@@ -0,0 +1,244 @@
+#include "CResultCache.h"
+
+CResultCache::CResultCache(size_t stMaxBytes, DWORD dwTimeToLive, CQueue* pWaitingQueue)
+{
+	m_stMaxShardBytes = stMaxBytes / RESULT_CACHE_SHARDS;
+	m_dwTimeToLive = dwTimeToLive;
+	m_pWaitingQueue = pWaitingQueue;
+	m_llHits = 0;
+	m_llMisses = 0;
+	m_llJoins = 0;
+	m_llEvictions = 0;
+
+	for (int i = 0; i < RESULT_CACHE_SHARDS; i++)
+	{
+		InitializeCriticalSection(&m_Shards[i].Protector);
+		m_Shards[i].stBytes = 0;
+	}
+}
+
+CResultCache::~CResultCache()
+{
+	for (int i = 0; i < RESULT_CACHE_SHARDS; i++)
+		DeleteCriticalSection(&m_Shards[i].Protector);
+}
+
+CResultCache::Shard& CResultCache::GetShard(const wstring& Key)
+{
+	// Use the high bits of the hash, because the unordered_maps of the shard pick their buckets from the low bits.
+	return m_Shards[hash<wstring>()(Key) >> ((sizeof(size_t) * 8) - RESULT_CACHE_SHARD_BITS)];
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method looks up the result of an item before it is dispatched to the processing threads.
+* On a hit, the cached result is set on the item. On a miss, the item is registered as the one computing
+* the result of its key, and the caller must dispatch it (or call Abandon if it could not be dispatched).
+* If another item with the same key is already being computed, the item waits for that computation, and
+* it is completed by Complete.
+*
+* @ingroup CResultCache
+*
+* @param pItem : IN - The item that is about to be dispatched.
+* @param bHighPriority : IN - The priority of the item, kept in case it has to be dispatched later.
+*
+* @return LookupResults : eHit if the item got the cached result, eJoined if it waits for another item,
+*	or eMiss if it must be processed.
+*/
+CResultCache::LookupResults CResultCache::Lookup(CQueueItem* pItem, bool bHighPriority/* = false*/)
+{
+	if (pItem->GetKey() == NULL)
+		return eMiss;
+
+	wstring	Key(pItem->GetKey());
+	Shard&	shard = GetShard(Key);
+
+	EnterCriticalSection(&shard.Protector);
+	unordered_map<wstring, EntryList::iterator>::iterator	EntryIter = shard.Entries.find(Key);
+
+	if (EntryIter != shard.Entries.end())
+	{
+		if (GetTickCount64() < EntryIter->second->ullExpiryTime)
+		{
+			// Move the entry to the front of the LRU list.
+			shard.LruList.splice(shard.LruList.begin(), shard.LruList, EntryIter->second);
+			pItem->SetResult(EntryIter->second->pResult);
+			LeaveCriticalSection(&shard.Protector);
+			InterlockedIncrement64(&m_llHits);
+			return eHit;
+		}
+
+		Remove(shard, EntryIter->second);
+		InterlockedIncrement64(&m_llEvictions);
+	}
+
+	unordered_map<wstring, InFlightEntry>::iterator	InFlightIter = shard.InFlight.find(Key);
+
+	if (InFlightIter != shard.InFlight.end())
+	{
+		WaitingItem	Waiter = { pItem, bHighPriority };
+
+		InFlightIter->second.Waiters.push_back(Waiter);
+		LeaveCriticalSection(&shard.Protector);
+		InterlockedIncrement64(&m_llJoins);
+		return eJoined;
+	}
+
+	// Drop the result of a previous run of the item, so it cannot be cached under this key if the item does not set a new one.
+	pItem->SetResult(ItemResultPtr());
+	shard.InFlight[Key].pLeader = pItem;
+	LeaveCriticalSection(&shard.Protector);
+	InterlockedIncrement64(&m_llMisses);
+	return eMiss;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method is called by the processing thread after it processes an item, and before the item is
+* marked as complete. It caches the result of the item, and completes the items that were waiting for it.
+* If the item did not produce a result, the waiting items are put in the waiting queue with their original
+* priority, to be processed on their own in parallel.
+*
+* @ingroup CResultCache
+*
+* @param pItem : IN - The item that was processed.
+*
+* @return void.
+*/
+void CResultCache::Complete(CQueueItem* pItem)
+{
+	if (pItem->GetKey() == NULL)
+		return;
+
+	wstring			Key(pItem->GetKey());
+	Shard&			shard = GetShard(Key);
+	ItemResultPtr	pResult = pItem->GetResult();
+	WaitingList		Waiters;
+
+	EnterCriticalSection(&shard.Protector);
+	TakeWaiters(shard, pItem, Key, Waiters);
+	if (pResult)
+		Insert(shard, Key, pResult);
+	LeaveCriticalSection(&shard.Protector);
+
+	for (WaitingList::iterator iter = Waiters.begin(); iter != Waiters.end(); ++iter)
+	{
+		if (pResult)
+		{
+			iter->pItem->SetResult(pResult);
+			iter->pItem->SetWorkComplete();
+		}
+		else if (!m_pWaitingQueue->Enqueue(iter->pItem, iter->bHighPriority))
+		{
+			iter->pItem->SetWorkCancelled();
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method is called when an item that got eMiss from Lookup could not be dispatched. The items that
+* were waiting for it are cancelled.
+*
+* @ingroup CResultCache
+*
+* @param pItem : IN - The item that was not dispatched.
+*
+* @return void.
+*/
+void CResultCache::Abandon(CQueueItem* pItem)
+{
+	if (pItem->GetKey() == NULL)
+		return;
+
+	wstring		Key(pItem->GetKey());
+	Shard&		shard = GetShard(Key);
+	WaitingList	Waiters;
+
+	EnterCriticalSection(&shard.Protector);
+	TakeWaiters(shard, pItem, Key, Waiters);
+	LeaveCriticalSection(&shard.Protector);
+
+	for (WaitingList::iterator iter = Waiters.begin(); iter != Waiters.end(); ++iter)
+		iter->pItem->SetWorkCancelled();
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method returns the counters of the cache and its current size.
+*
+* @ingroup CResultCache
+*
+* @param none.
+*
+* @return Statistics.
+*/
+CResultCache::Statistics CResultCache::GetStatistics()
+{
+	Statistics	Stats;
+
+	Stats.llHits = m_llHits;
+	Stats.llMisses = m_llMisses;
+	Stats.llJoins = m_llJoins;
+	Stats.llEvictions = m_llEvictions;
+	Stats.stEntries = 0;
+	Stats.stBytes = 0;
+
+	for (int i = 0; i < RESULT_CACHE_SHARDS; i++)
+	{
+		EnterCriticalSection(&m_Shards[i].Protector);
+		Stats.stEntries += m_Shards[i].LruList.size();
+		Stats.stBytes += m_Shards[i].stBytes;
+		LeaveCriticalSection(&m_Shards[i].Protector);
+	}
+	return Stats;
+}
+
+// NOTE: The shard must be locked by the caller of the following methods.
+
+void CResultCache::Insert(Shard& shard, const wstring& Key, const ItemResultPtr& pResult)
+{
+	unordered_map<wstring, EntryList::iterator>::iterator	EntryIter = shard.Entries.find(Key);
+	CacheEntry												Entry;
+
+	if (EntryIter != shard.Entries.end())
+		Remove(shard, EntryIter->second);
+
+	Entry.Key = Key;
+	Entry.pResult = pResult;
+	Entry.ullExpiryTime = (m_dwTimeToLive == INFINITE) ? ~0ULL : GetTickCount64() + m_dwTimeToLive;
+	Entry.stSize = sizeof(CacheEntry) + (Key.size() * sizeof(wchar_t)) + pResult->GetSize();
+
+	// Don't cache a result that alone does not fit in the memory budget of the shard.
+	if (Entry.stSize > m_stMaxShardBytes)
+		return;
+
+	shard.LruList.push_front(Entry);
+	shard.Entries[Key] = shard.LruList.begin();
+	shard.stBytes += Entry.stSize;
+
+	// Evict the least recently used entries until the shard is within its memory budget.
+	while (shard.stBytes > m_stMaxShardBytes)
+	{
+		Remove(shard, --shard.LruList.end());
+		InterlockedIncrement64(&m_llEvictions);
+	}
+}
+
+void CResultCache::Remove(Shard& shard, EntryList::iterator EntryIter)
+{
+	shard.stBytes -= EntryIter->stSize;
+	shard.Entries.erase(EntryIter->Key);
+	shard.LruList.erase(EntryIter);
+}
+
+void CResultCache::TakeWaiters(Shard& shard, CQueueItem* pLeader, const wstring& Key, WaitingList& Waiters)
+{
+	unordered_map<wstring, InFlightEntry>::iterator	InFlightIter = shard.InFlight.find(Key);
+
+	if ((InFlightIter == shard.InFlight.end()) || (InFlightIter->second.pLeader != pLeader))
+		return;
+
+	Waiters.swap(InFlightIter->second.Waiters);
+	shard.InFlight.erase(InFlightIter);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <Windows.h>
+#include <string>
+#include <unordered_map>
+#include "CQueue.h"
+
+using namespace std;
+
+#define RESULT_CACHE_SHARD_BITS	4
+#define RESULT_CACHE_SHARDS		(1 << RESULT_CACHE_SHARD_BITS)
+
+// Concurrent LRU cache of item results keyed by CQueueItem::GetKey(), with expiry time for the entries and a memory budget.
+// It also tracks the items in progress, so the items that are submitted for a key while it is being computed wait for that
+// computation instead of computing it again.
+class CResultCache
+{
+public:
+	typedef enum { eHit, eMiss, eJoined } LookupResults;
+
+	struct Statistics
+	{
+		LONG64	llHits;			// Items completed from the cache.
+		LONG64	llMisses;		// Items dispatched to the processing threads.
+		LONG64	llJoins;		// Items that waited for the computation of another item with the same key.
+		LONG64	llEvictions;	// Entries removed because of the memory budget or because they expired.
+		size_t	stEntries;
+		size_t	stBytes;
+	};
+
+private:
+	struct CacheEntry
+	{
+		wstring			Key;
+		ItemResultPtr	pResult;
+		ULONGLONG		ullExpiryTime;
+		size_t			stSize;
+	};
+	typedef list<CacheEntry>	EntryList;
+
+	struct WaitingItem
+	{
+		CQueueItem*		pItem;
+		bool			bHighPriority;
+	};
+	typedef list<WaitingItem>	WaitingList;
+
+	struct InFlightEntry
+	{
+		CQueueItem*		pLeader;	// The item that computes the result.
+		WaitingList		Waiters;	// The items waiting for the result of pLeader.
+	};
+
+	struct Shard
+	{
+		CRITICAL_SECTION							Protector;
+		EntryList									LruList; // The most recently used entry is at the front.
+		unordered_map<wstring, EntryList::iterator>	Entries;
+		unordered_map<wstring, InFlightEntry>		InFlight;
+		size_t										stBytes;
+	};
+
+	Shard				m_Shards[RESULT_CACHE_SHARDS];
+	size_t				m_stMaxShardBytes;
+	DWORD				m_dwTimeToLive;
+	CQueue*				m_pWaitingQueue;
+	volatile LONG64		m_llHits;
+	volatile LONG64		m_llMisses;
+	volatile LONG64		m_llJoins;
+	volatile LONG64		m_llEvictions;
+
+public:
+	CResultCache(size_t stMaxBytes, DWORD dwTimeToLive, CQueue* pWaitingQueue);
+	~CResultCache();
+	LookupResults Lookup(CQueueItem* pItem, bool bHighPriority = false);
+	void Complete(CQueueItem* pItem);
+	void Abandon(CQueueItem* pItem);
+	Statistics GetStatistics();
+
+private:
+	Shard& GetShard(const wstring& Key);
+	void Insert(Shard& shard, const wstring& Key, const ItemResultPtr& pResult);
+	void Remove(Shard& shard, EntryList::iterator EntryIter);
+	void TakeWaiters(Shard& shard, CQueueItem* pLeader, const wstring& Key, WaitingList& Waiters);
+};
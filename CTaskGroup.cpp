@@ -0,0 +1,70 @@
+#include "CTaskGroup.h"
+
+CTaskGroup::CTaskGroup()
+{
+	m_lPendingTasks = 0;
+	m_lFinishingTasks = 0;
+	m_hDoneEvent = NULL;
+}
+
+CTaskGroup::~CTaskGroup()
+{
+	if (m_hDoneEvent != NULL)
+		CloseHandle(m_hDoneEvent);
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method is called by a task of the group after it finishes its work. The last task wakes up the
+* thread waiting in WaitForTasks.
+*
+* @ingroup CTaskGroup
+*
+* @param none.
+*
+* @return void.
+*/
+void CTaskGroup::TaskDone()
+{
+	// IsDone stays false until this method stops touching the group, so Sync cannot return and destroy it in the meantime.
+	InterlockedIncrement(&m_lFinishingTasks);
+	if ((InterlockedDecrement(&m_lPendingTasks) == 0) && (m_hDoneEvent != NULL))
+		SetEvent(m_hDoneEvent);
+	InterlockedDecrement(&m_lFinishingTasks);
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method blocks the thread waiting for the group, until the last pending task of the group is done
+* or the timeout elapses. It must be called by one thread only, the one that calls Sync on the group.
+*
+* @ingroup CTaskGroup
+*
+* @param dwTimeout : IN - The maximum time to wait in milliseconds.
+*
+* @return void.
+*/
+void CTaskGroup::WaitForTasks(DWORD dwTimeout)
+{
+	if (m_hDoneEvent == NULL)
+	{
+		HANDLE	hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		if (hEvent == NULL)
+		{
+			// Log error here about failing to create the event, and poll the group instead of blocking on it.
+			fwprintf(stderr, L"Method(%s):Line(%d)ERROR: Failed to create the event of the task group (error: %u).\n", __FUNCTIONW__, __LINE__, GetLastError());
+			Sleep(1);
+			return;
+		}
+		InterlockedExchangePointer((PVOID volatile*)&m_hDoneEvent, hEvent);
+	}
+
+	ResetEvent(m_hDoneEvent);
+
+	// Check the pending tasks after resetting the event, so a task that is done in between is not missed.
+	if (m_lPendingTasks == 0)
+		SwitchToThread(); // The last task is leaving the group, there is nothing to block for.
+	else
+		WaitForSingleObject(m_hDoneEvent, dwTimeout);
+}
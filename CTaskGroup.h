@@ -0,0 +1,27 @@
+#pragma once
+#include <Windows.h>
+#include <list>
+
+using namespace std;
+
+class CTaskItem;
+
+typedef list<CTaskItem*>			TasksQueue;
+typedef TasksQueue::iterator		TasksQueueIter;
+
+// Counts the tasks spawned into the thread pool that have not finished yet, so the spawning thread can wait (Sync) for all of them.
+class CTaskGroup
+{
+	volatile LONG	m_lPendingTasks;
+	volatile LONG	m_lFinishingTasks;	// Tasks that are past their work but may still touch this group, so it must not be destroyed yet.
+	HANDLE volatile	m_hDoneEvent;		// Created only when the waiting thread has to block, and signaled when the last pending task is done.
+	TasksQueue		m_QueuedTasks;		// The tasks of this group that are still in CTaskQueue, protected by the lock of CTaskQueue.
+public:
+	CTaskGroup();
+	~CTaskGroup();
+	void AddTask() { InterlockedIncrement(&m_lPendingTasks); }
+	void TaskDone();
+	bool IsDone() { return (m_lPendingTasks == 0) && (m_lFinishingTasks == 0); }
+	void WaitForTasks(DWORD dwTimeout);
+	TasksQueue& GetQueuedTasks() { return m_QueuedTasks; }
+};
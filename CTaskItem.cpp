@@ -0,0 +1,27 @@
+#include "CTaskItem.h"
+
+CTaskItem::CTaskItem(CTaskGroup* pGroup, const TaskFunction& Function)
+{
+	m_pGroup = pGroup;
+	m_Function = Function;
+}
+
+CTaskItem::~CTaskItem()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method runs the function of the task, then marks the task as done in its task group.
+*
+* @ingroup CTaskItem
+*
+* @param none.
+*
+* @return void.
+*/
+void CTaskItem::Execute()
+{
+	m_Function();
+	m_pGroup->TaskDone();
+}
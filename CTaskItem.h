@@ -0,0 +1,26 @@
+#pragma once
+#include <functional>
+#include "CTaskGroup.h"
+
+using namespace std;
+
+typedef function<void()>					TaskFunction;
+typedef function<void(size_t, size_t)>		RangeFunction;
+
+// A function spawned into the thread pool by CThreadsManager::Spawn. Tasks are not passed to CThread::ProcessItem,
+// they are executed directly by idle processing threads and by the threads waiting in Sync.
+class CTaskItem
+{
+	CTaskGroup*		m_pGroup;
+	TaskFunction	m_Function;
+	TasksQueueIter	m_QueueIter;	// Position of the task in the queue of CTaskQueue.
+	TasksQueueIter	m_GroupIter;	// Position of the task in the queued tasks of its group.
+public:
+	CTaskItem(CTaskGroup* pGroup, const TaskFunction& Function);
+	~CTaskItem();
+	CTaskGroup* GetGroup() { return m_pGroup; }
+	void Execute();
+	void SetQueuePositions(TasksQueueIter QueueIter, TasksQueueIter GroupIter) { m_QueueIter = QueueIter; m_GroupIter = GroupIter; }
+	TasksQueueIter GetQueuePosition() { return m_QueueIter; }
+	TasksQueueIter GetGroupPosition() { return m_GroupIter; }
+};
@@ -0,0 +1,161 @@
+#include "CTaskQueue.h"
+
+#define MAX_TASK_WAKEUPS		0x7FFFFFFF
+
+CTaskQueue::CTaskQueue()
+{
+	m_lWaitingThreads = 0;
+	m_hTaskSemaphore = CreateSemaphore(NULL, 0, MAX_TASK_WAKEUPS, NULL);
+	InitializeCriticalSection(&m_TasksProtector);
+}
+
+CTaskQueue::~CTaskQueue()
+{
+	EnterCriticalSection(&m_TasksProtector);
+	for (TasksQueueIter iter = m_Tasks.begin(); iter != m_Tasks.end(); ++iter)
+	{
+		delete (*iter);
+	}
+	m_Tasks.clear();
+	LeaveCriticalSection(&m_TasksProtector);
+
+	CloseHandle(m_hTaskSemaphore);
+	DeleteCriticalSection(&m_TasksProtector);
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method adds a task to the end of the queue, and wakes up a processing thread if one is waiting.
+*
+* @ingroup CTaskQueue
+*
+* @param pTask : IN - The task to add. The queue owns it after it is added.
+*
+* @return bool : true if the task is added, false if the queue is full.
+*/
+bool CTaskQueue::Push(CTaskItem* pTask)
+{
+	EnterCriticalSection(&m_TasksProtector);
+	if (m_Tasks.size() >= m_cstMaxTasks)
+	{
+		// A full queue is not an error, the caller executes the task itself.
+		LeaveCriticalSection(&m_TasksProtector);
+		return false;
+	}
+	m_Tasks.push_back(pTask);
+	pTask->GetGroup()->GetQueuedTasks().push_back(pTask);
+	pTask->SetQueuePositions(--m_Tasks.end(), --pTask->GetGroup()->GetQueuedTasks().end());
+	LeaveCriticalSection(&m_TasksProtector);
+
+	// Pairs with the InterlockedIncrement in WaitForTask: either the waiting thread sees this task, or this thread sees it waiting.
+	MemoryBarrier();
+	if (TakeWaitingThread())
+		ReleaseSemaphore(m_hTaskSemaphore, 1, NULL);
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method takes a task out of the queue, executes it and de-allocates it.
+*
+* @ingroup CTaskQueue
+*
+* @param pGroup : IN - If NULL, the oldest task in the queue is executed. Otherwise, the newest task of this
+*	group is executed, and the tasks of other groups are left for other threads.
+*
+* @return bool : true if a task was executed, false if there was no task to execute.
+*/
+bool CTaskQueue::ExecuteNext(CTaskGroup* pGroup/* = NULL*/)
+{
+	CTaskItem*	pTask = NULL;
+
+	EnterCriticalSection(&m_TasksProtector);
+	if (pGroup == NULL)
+	{
+		if (m_Tasks.size() > 0)
+		{
+			pTask = m_Tasks.front();
+			m_Tasks.pop_front();
+			pTask->GetGroup()->GetQueuedTasks().erase(pTask->GetGroupPosition());
+		}
+	}
+	else if (pGroup->GetQueuedTasks().size() > 0)
+	{
+		pTask = pGroup->GetQueuedTasks().back();
+		pGroup->GetQueuedTasks().pop_back();
+		m_Tasks.erase(pTask->GetQueuePosition());
+	}
+	LeaveCriticalSection(&m_TasksProtector);
+
+	if (pTask == NULL)
+		return false;
+
+	pTask->Execute();
+	delete pTask;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method blocks an idle processing thread until a task is pushed, the stop event is signaled or the
+* timeout elapses.
+*
+* @ingroup CTaskQueue
+*
+* @param hStopEvent : IN - The stop event of the processing threads.
+* @param dwTimeout : IN - The maximum time to wait in milliseconds.
+*
+* @return bool : true if the stop event was signaled, false otherwise.
+*/
+bool CTaskQueue::WaitForTask(HANDLE hStopEvent, DWORD dwTimeout)
+{
+	HANDLE	Handles[2] = { hStopEvent, m_hTaskSemaphore };
+	DWORD	dwResult;
+
+	InterlockedIncrement(&m_lWaitingThreads);
+
+	// Don't block if a task was pushed before this thread was counted as waiting.
+	dwResult = (Size() > 0) ? WAIT_TIMEOUT : WaitForMultipleObjects(2, Handles, FALSE, dwTimeout);
+
+	// A thread woken up by the semaphore was already taken out of the count by Push. Otherwise, take it out now, unless
+	// a Push took it out first, and then consume the wake-up that Push releases for it, so no extra count is left behind.
+	if ((dwResult != (WAIT_OBJECT_0 + 1)) && !TakeWaitingThread())
+		WaitForSingleObject(m_hTaskSemaphore, INFINITE);
+
+	return (dwResult == WAIT_OBJECT_0);
+}
+
+size_t CTaskQueue::Size()
+{
+	size_t	stCount = 0;
+
+	EnterCriticalSection(&m_TasksProtector);
+	stCount = m_Tasks.size();
+	LeaveCriticalSection(&m_TasksProtector);
+	return stCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method takes one waiting thread out of the count of waiting threads, if there is one.
+*
+* @ingroup CTaskQueue
+*
+* @param none.
+*
+* @return bool : true if a waiting thread was taken out of the count, false if there was none.
+*/
+bool CTaskQueue::TakeWaitingThread()
+{
+	LONG	lWaiting = m_lWaitingThreads;
+
+	while (lWaiting > 0)
+	{
+		LONG	lPrevious = InterlockedCompareExchange(&m_lWaitingThreads, lWaiting - 1, lWaiting);
+
+		if (lPrevious == lWaiting)
+			return true;
+		lWaiting = lPrevious;
+	}
+	return false;
+}
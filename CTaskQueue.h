@@ -0,0 +1,27 @@
+#pragma once
+#include <Windows.h>
+#include <list>
+#include "CTaskItem.h"
+
+using namespace std;
+
+// The queue of the tasks spawned into the thread pool. The processing threads take the oldest tasks, and a thread waiting
+// in Sync takes only the newest tasks of its own group, so its nesting depth is bounded by the depth of its own task tree.
+class CTaskQueue
+{
+	const size_t		m_cstMaxTasks = 100000; // When the queue is full, the tasks are executed by the spawning thread instead.
+	TasksQueue			m_Tasks;
+	CRITICAL_SECTION	m_TasksProtector;
+	HANDLE				m_hTaskSemaphore;
+	volatile LONG		m_lWaitingThreads;	// The number of processing threads blocked in WaitForTask that no Push has woken up yet.
+public:
+	CTaskQueue();
+	~CTaskQueue();
+	bool Push(CTaskItem* pTask);
+	bool ExecuteNext(CTaskGroup* pGroup = NULL);
+	bool WaitForTask(HANDLE hStopEvent, DWORD dwTimeout);
+	size_t Size();
+
+private:
+	bool TakeWaitingThread();
+};
@@ -1,4 +1,5 @@
 #include "CThread.h"
+#include "CResultCache.h"
 
 CThread::CThread(int iId, HANDLE* phStopEvent, unsigned int* pCounter)
 {
@@ -10,6 +11,9 @@ CThread::CThread(int iId, HANDLE* phStopEvent, unsigned int* pCounter)
 	m_State = eIdle;
 	m_bRunning = false;
 	m_pItem = NULL;
+	m_pTaskQueue = NULL;
+	m_lClaim = eUnclaimed;
+	m_pResultCache = NULL;
 	m_hThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)ThreadMain, this, 0, &dwThreadId);
 
 	if (m_hThread == NULL)
@@ -55,6 +59,10 @@ void CThread::ThreadMain(void *pParam)
 				// Process the item assigned to this thread.
 				pThis->m_pItem->SetWorkStarted();
 				pThis->ProcessItem(pThis->m_pItem);
+
+				// Cache the result and complete the items waiting for it, before the owner of this item is told that it is complete.
+				if (pThis->m_pResultCache != NULL)
+					pThis->m_pResultCache->Complete(pThis->m_pItem);
 				pThis->m_pItem->SetWorkComplete();
 
 				// NOTE: The owner of this item is responsible for monitoring its state, to be able to de-allocate it after it is processed.
@@ -62,11 +70,37 @@ void CThread::ThreadMain(void *pParam)
 				pThis->m_pItem = NULL;
 			}
 			else
+			{
 				pThis->m_State = eIdle;
+				pThis->ReleaseClaim();
+			}
+		}
+
+		// An idle thread helps executing the tasks spawned into the thread pool, and it waits for new tasks only when there are none left.
+		// It claims itself first, so the manager does not assign it an item while it executes a task, which may take long.
+		bool	bWait = pThis->IsIdle();
+
+		if (bWait && (pThis->m_pTaskQueue != NULL))
+		{
+			if (pThis->ClaimForTask())
+			{
+				bWait = !pThis->m_pTaskQueue->ExecuteNext();
+				pThis->ReleaseClaim();
+			}
+			else
+				bWait = false; // The manager is assigning an item to this thread.
 		}
 
 		// Check if the stop event was signaled
-		if (WaitForSingleObject(*(pThis->m_phStopEvent), pThis->IsIdle() ? 500 : 0) == WAIT_OBJECT_0)
+		if (bWait && (pThis->m_pTaskQueue != NULL))
+		{
+			if (pThis->m_pTaskQueue->WaitForTask(*(pThis->m_phStopEvent), 500))
+			{
+				// Log information message here about detecting stop event.
+				bDone = true;
+			}
+		}
+		else if (WaitForSingleObject(*(pThis->m_phStopEvent), bWait ? 500 : 0) == WAIT_OBJECT_0)
 		{
 			// Log information message here about detecting stop event.
 			bDone = true;
@@ -1,10 +1,14 @@
 #pragma once
 #include "CQueue.h"
+#include "CTaskQueue.h"
+
+class CResultCache;
 
 class CThread
 {
 public:
 	typedef enum { eActive, eIdle, eDead } States;
+	typedef enum { eUnclaimed, eClaimedForItem, eClaimedForTask } Claims;
 
 private:
 	int				m_iId;
@@ -14,6 +18,9 @@ private:
 	unsigned int*	m_puiThreadsCounter; // Pointer to unsigned int member variable in CQueue, which holds the number of threads working together on the that queue.
 	HANDLE*			m_phStopEvent;
 	CQueueItem*		m_pItem;
+	CTaskQueue*		m_pTaskQueue; // Pointer to the queue of spawned tasks in CThreadsManager, which this thread executes while it is idle.
+	volatile LONG	m_lClaim; // Who owns an idle thread: the manager assigning it an item, or the thread itself executing a task.
+	CResultCache*	m_pResultCache; // Pointer to the result cache in CThreadsManager, or NULL if the cache is not enabled.
 
 public:
 	bool IsDead() { return m_State == eDead; }
@@ -26,11 +33,16 @@ public:
 	HANDLE GetThreadHandle() { return m_hThread; }
 	CQueueItem* GetItem() { return m_pItem; }
 	void SetItem(CQueueItem* pItem) { m_pItem = pItem; }
+	void SetTaskSource(CTaskQueue* pTaskQueue) { m_pTaskQueue = pTaskQueue; }
+	bool ClaimForItem() { return (InterlockedCompareExchange(&m_lClaim, eClaimedForItem, eUnclaimed) == eUnclaimed); }
+	void SetResultCache(CResultCache* pResultCache) { m_pResultCache = pResultCache; }
 	CThread(int iId, HANDLE* phStopEvent, unsigned int* pCounter);
 	virtual ~CThread();
 
 private:
 	static void __stdcall ThreadMain(void *pParam);
+	bool ClaimForTask() { return (InterlockedCompareExchange(&m_lClaim, eClaimedForTask, eUnclaimed) == eUnclaimed); }
+	void ReleaseClaim() { InterlockedExchange(&m_lClaim, eUnclaimed); }
 
 protected:
 	virtual void ProcessItem(CQueueItem* pQItem) = 0;
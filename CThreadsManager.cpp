@@ -3,6 +3,8 @@
 
 #define MAX_THREADS_COUNT		1000
 #define DEFAULT_THREADS_COUNT	100
+#define CHUNKS_PER_THREAD		8
+#define SYNC_WAIT_TIMEOUT		100
 
 using namespace std;
 
@@ -23,6 +25,7 @@ CThreadsManager::CThreadsManager(unsigned int uiThreads)
 	m_bRunning = false;
 	m_uiRunningThreadsCounter = 0;
 	m_uiThreads = uiThreads;
+	m_pResultCache = NULL;
 
 	// No exception handling for InitializeCriticalSection, because In this program I neither support Windows Server 2003 nor Windows XP.
 	// The following is written on MSDN: https://msdn.microsoft.com/en-us/library/windows/desktop/ms683472(v=vs.85).aspx
@@ -42,6 +45,9 @@ CThreadsManager::~CThreadsManager()
 	if (m_hThread != NULL)
 		CloseHandle(m_hThread);
 
+	if (m_pResultCache != NULL)
+		delete m_pResultCache;
+
 	DeleteCriticalSection(&m_MembersProtector);
 }
 
@@ -95,6 +101,54 @@ void CThreadsManager::Stop()
 	WaitForSingleObject(m_hCompletionEvent, 10000);
 }
 
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method enables the result cache, so items whose key was processed recently are completed with
+* the cached result instead of being processed again, and items submitted while an item with the same key
+* is in progress wait for its result. The processing threads must set the result on the items they
+* process (CQueueItem::SetResult), items without a result are not cached.
+* NOTE: It must be called before Start.
+*
+* @ingroup : CThreadsManager
+*
+* @param stMaxBytes : IN - The memory budget of the cache, the least recently used results are evicted to stay within it.
+*	The budget is split evenly between the RESULT_CACHE_SHARDS shards of the cache, so a result that is bigger than
+*	stMaxBytes / RESULT_CACHE_SHARDS (including its key) is never cached.
+* @param dwTimeToLive : IN - The time in milliseconds after which a cached result expires, or INFINITE.
+*
+* @return bool : true if the cache is enabled, false otherwise.
+*/
+bool CThreadsManager::EnableResultCache(size_t stMaxBytes, DWORD dwTimeToLive/* = INFINITE*/)
+{
+	if ((m_hThread != NULL) || (m_pResultCache != NULL))
+	{
+		fwprintf(stderr, L"Method(%s):Line(%d)WARNING: The result cache can be enabled only once, before the thread pool manager is started.\n", __FUNCTIONW__, __LINE__);
+		return false;
+	}
+
+	m_pResultCache = new CResultCache(stMaxBytes, dwTimeToLive, &m_WaitingQueue);
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method gets the hit, miss and eviction counters of the result cache, and its current size.
+*
+* @ingroup : CThreadsManager
+*
+* @param Stats : OUT - The statistics of the result cache.
+*
+* @return bool : true if the result cache is enabled, false otherwise.
+*/
+bool CThreadsManager::GetResultCacheStatistics(CResultCache::Statistics& Stats)
+{
+	if (m_pResultCache == NULL)
+		return false;
+
+	Stats = m_pResultCache->GetStatistics();
+	return true;
+}
+
 //--------------------------------------------------------------------------------------------------
 /*!
 * This is the thread main method of the thread pool manager, which is responsible for managing the thread pool.
@@ -163,6 +217,8 @@ void CThreadsManager::CreateAndStartThreads()
 		}
 		else
 		{
+			pThread->SetTaskSource(&m_TaskQueue);
+			pThread->SetResultCache(m_pResultCache);
 			m_IdleThreadList.push_back(pThread);
 		}
 	}
@@ -298,14 +354,22 @@ void CThreadsManager::AssignWorkToIdleThreads()
 	// While there is at least one idle thread and at least one item in the queue waiting to be translated, ...
 	while ((m_IdleThreadList.size() > 0) && (m_WaitingQueue.Size() > 0))
 	{
-		// Get an item from the waiting list (queue).
-		pQItem = m_WaitingQueue.Dequeue();
+		// Get the next idle thread that is not busy executing a spawned task.
+		for (ThreadIter = m_IdleThreadList.begin(); ThreadIter != m_IdleThreadList.end(); ++ThreadIter)
+		{
+			if ((*ThreadIter)->ClaimForItem())
+				break;
+		}
+
+		if (ThreadIter == m_IdleThreadList.end())
+			break;
 
-		// Get the next idle thread.
-		ThreadIter = m_IdleThreadList.begin();
 		pThread = *ThreadIter;
 		m_IdleThreadList.erase(ThreadIter);
 
+		// Get an item from the waiting list (queue).
+		pQItem = m_WaitingQueue.Dequeue();
+
 		// Assign the item to the thread and set the thread state to active.
 		pThread->SetItem(pQItem);
 		pThread->SetActive();
@@ -316,6 +380,48 @@ void CThreadsManager::AssignWorkToIdleThreads()
 	Unlock();
 }
 
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method adds an item to the waiting queue. If the result cache is enabled, the item is completed
+* right away when its result is cached, and it waits without being queued when an item with the same key
+* is already in progress.
+*
+* @ingroup CThreadsManager
+*
+* @param pItemToProcess : The item needs to be processed.
+* @param bHighPriority : The priority of the item that needs to be processed.
+*
+* @return bool : true if the item is dispatched or completed, false otherwise.
+*/
+bool CThreadsManager::DispatchItem(CQueueItem* pItemToProcess, bool bHighPriority)
+{
+	bool	bResult;
+
+	// The cache is looked up without holding the manager lock, it has its own lock per shard.
+	if (m_pResultCache != NULL)
+	{
+		switch (m_pResultCache->Lookup(pItemToProcess, bHighPriority))
+		{
+		case CResultCache::eHit:
+			pItemToProcess->SetWorkComplete();
+			return true;
+		case CResultCache::eJoined:
+			return true;
+		default:
+			break;
+		}
+	}
+
+	Lock();
+	bResult = m_WaitingQueue.Enqueue(pItemToProcess, bHighPriority);
+	Unlock();
+
+	// The items waiting for this one will not get a result.
+	if (!bResult && (m_pResultCache != NULL))
+		m_pResultCache->Abandon(pItemToProcess);
+	return bResult;
+}
+
 //--------------------------------------------------------------------------------------------------
 /*!
 * This method adds a new item to the waiting queue, to be processed by the processing threads.
@@ -339,11 +445,7 @@ bool CThreadsManager::ProcessItemAsynchronous(CQueueItem* pItemToProcess, bool b
 		return false;
 	}
 
-	bool	bResult;
-
-	Lock();
-	bResult = m_WaitingQueue.Enqueue(pItemToProcess, bHighPriority);
-	Unlock();
+	bool	bResult = DispatchItem(pItemToProcess, bHighPriority);
 
 	return bResult;
 }
@@ -370,11 +472,7 @@ bool CThreadsManager::ProcessItemSynchronous(CQueueItem* pItemToProcess, bool bH
 		return false;
 	}
 
-	bool	bResult;
-
-	Lock();
-	bResult = m_WaitingQueue.Enqueue(pItemToProcess, bHighPriority);
-	Unlock();
+	bool	bResult = DispatchItem(pItemToProcess, bHighPriority);
 
 	while (!pItemToProcess->IsCompleted())
 	{
@@ -384,4 +482,124 @@ bool CThreadsManager::ProcessItemSynchronous(CQueueItem* pItemToProcess, bool bH
 	}
 
 	return bResult;
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method spawns a task into the thread pool (fork). The task is executed by the first idle processing
+* thread, or by the thread waiting in Sync on the same group, whichever gets to it first. If the tasks
+* queue is full, the task is executed right away by the calling thread.
+*
+* @ingroup CThreadsManager
+*
+* @param pGroup : IN - The task group that tracks the task. Call Sync on the same group to wait for it (join).
+* @param Function : IN - The function that the task executes.
+*
+* @return void.
+*/
+void CThreadsManager::Spawn(CTaskGroup* pGroup, const TaskFunction& Function)
+{
+	if (pGroup == NULL)
+	{
+		fwprintf(stderr, L"Method(%s):Line(%d)WARNING: Invalid task group, the task is skipped.\n", __FUNCTIONW__, __LINE__);
+		return;
+	}
+
+	CTaskItem*	pTask = new CTaskItem(pGroup, Function);
+
+	pGroup->AddTask();
+	if (!m_TaskQueue.Push(pTask))
+	{
+		// The tasks queue is full, so execute the task in the calling thread instead.
+		pTask->Execute();
+		delete pTask;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method waits for all the tasks spawned in a task group to complete (join). The calling thread
+* helps executing the tasks of this group that are still queued, so Sync can be called safely from inside
+* a task and the work gets done even if the thread pool is not started. It runs only the tasks of its own
+* group, so the nesting depth stays bounded by the depth of the task tree. When the remaining tasks are
+* all running on other threads, it blocks until they are done.
+*
+* @ingroup CThreadsManager
+*
+* @param pGroup : IN - The task group to wait for.
+*
+* @return void.
+*/
+void CThreadsManager::Sync(CTaskGroup* pGroup)
+{
+	if (pGroup == NULL)
+		return;
+
+	while (!pGroup->IsDone())
+	{
+		if (!m_TaskQueue.ExecuteNext(pGroup))
+			pGroup->WaitForTasks(SYNC_WAIT_TIMEOUT);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method calls Function on sub-ranges of [stBegin, stEnd) in parallel, and returns after the whole
+* range is processed. The range is split recursively, and the calling thread processes a part of it.
+*
+* @ingroup CThreadsManager
+*
+* @param stBegin : IN - The first index in the range.
+* @param stEnd : IN - One past the last index in the range.
+* @param stGrain : IN - The maximum size of a sub-range that is not split any more. Pass 0 to choose it
+*	automatically, so that every processing thread (and the calling thread) gets about CHUNKS_PER_THREAD
+*	sub-ranges, which is enough to balance the load without paying noticeable overhead per sub-range.
+* @param Function : IN - The function that processes the sub-range [first parameter, second parameter).
+*
+* @return void.
+*/
+void CThreadsManager::ParallelFor(size_t stBegin, size_t stEnd, size_t stGrain, const RangeFunction& Function)
+{
+	if (stEnd <= stBegin)
+		return;
+
+	if (stGrain == 0)
+	{
+		stGrain = (stEnd - stBegin) / ((m_uiThreads + 1) * CHUNKS_PER_THREAD);
+		if (stGrain == 0)
+			stGrain = 1;
+	}
+
+	ParallelForRange(stBegin, stEnd, stGrain, Function);
+}
+
+//--------------------------------------------------------------------------------------------------
+/*!
+* This method splits [stBegin, stEnd) in halves, spawning the upper half (which splits itself the same way)
+* and keeping the lower half, until the range is not bigger than the grain size. Then it processes the
+* remaining range and waits for the spawned halves.
+*
+* @ingroup CThreadsManager
+*
+* @param stBegin : IN - The first index in the range.
+* @param stEnd : IN - One past the last index in the range.
+* @param stGrain : IN - The maximum size of a sub-range that is not split any more.
+* @param Function : IN - The function that processes the sub-ranges.
+*
+* @return void.
+*/
+void CThreadsManager::ParallelForRange(size_t stBegin, size_t stEnd, size_t stGrain, const RangeFunction& Function)
+{
+	CTaskGroup	Group;
+
+	while ((stEnd - stBegin) > stGrain)
+	{
+		size_t	stMiddle = stBegin + (stEnd - stBegin) / 2;
+
+		Spawn(&Group, [this, stMiddle, stEnd, stGrain, &Function]() { ParallelForRange(stMiddle, stEnd, stGrain, Function); });
+		stEnd = stMiddle;
+	}
+
+	Function(stBegin, stEnd);
+	Sync(&Group);
 }
\ No newline at end of file
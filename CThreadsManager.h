@@ -2,6 +2,8 @@
 #include <Windows.h>
 #include "CThread.h"
 #include "CQueue.h"
+#include "CTaskQueue.h"
+#include "CResultCache.h"
 #include <vector>
 
 using namespace std;
@@ -20,15 +22,22 @@ class CThreadsManager
 	ThreadList			m_IdleThreadList;
 	ThreadList			m_ActiveThreadList;
 	CRITICAL_SECTION	m_MembersProtector;
+	CResultCache*		m_pResultCache;
 protected:
 	CQueue				m_WaitingQueue;
+	CTaskQueue			m_TaskQueue;
 
 public:
 	CThreadsManager(unsigned int uiThreads);
 	~CThreadsManager();
 	void Start();
+	bool EnableResultCache(size_t stMaxBytes, DWORD dwTimeToLive = INFINITE);
+	bool GetResultCacheStatistics(CResultCache::Statistics& Stats);
 	bool ProcessItemAsynchronous(CQueueItem* pItemToProcess, bool bHighPriority = false);
 	bool ProcessItemSynchronous(CQueueItem* pItemToProcess, bool bHighPriority = false);
+	void Spawn(CTaskGroup* pGroup, const TaskFunction& Function);
+	void Sync(CTaskGroup* pGroup);
+	void ParallelFor(size_t stBegin, size_t stEnd, size_t stGrain, const RangeFunction& Function);
 
 private:
 	void Stop();
@@ -37,6 +46,8 @@ private:
 	void StopAndDestroyThreads();
 	void MoveCompletedThreadsToIdleList();
 	void AssignWorkToIdleThreads();
+	bool DispatchItem(CQueueItem* pItemToProcess, bool bHighPriority);
+	void ParallelForRange(size_t stBegin, size_t stEnd, size_t stGrain, const RangeFunction& Function);
 
 protected:
 	void Lock() { EnterCriticalSection(&m_MembersProtector); }